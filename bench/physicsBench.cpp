@@ -0,0 +1,66 @@
+// Headless physics benchmark, drops crates on a flat dungeon floor and times
+// the fixed steps until everything fell asleep. Needs no Vulkan device.
+
+#include "vkh/collisionWorld.hpp"
+#include "vkh/systems/physics/physicsWorld.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <print>
+#include <random>
+
+int main(int argc, char **argv) {
+  const size_t crateCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10)
+                                     : 10'000;
+  const int floorTiles = 128;
+  const float tileSize = 2.f;
+
+  vkh::CollisionWorld staticWorld(tileSize);
+  uint32_t id = 0;
+  for (int x = 0; x < floorTiles; x++)
+    for (int z = 0; z < floorTiles; z++)
+      staticWorld.insert(
+          id++, AABB{{x * tileSize, -.1f, z * tileSize},
+                     {(x + 1) * tileSize, 0.f, (z + 1) * tileSize}});
+
+  vkh::PhysicsWorld world(staticWorld);
+  std::mt19937 rng{1234};
+  std::uniform_real_distribution<float> horizontal(
+      1.f, floorTiles * tileSize - 1.f);
+  std::uniform_real_distribution<float> height(2.f, 20.f);
+  for (size_t i = 0; i < crateCount; i++)
+    world.addBody({horizontal(rng), height(rng), horizontal(rng)},
+                  glm::vec3{.25f}, 10.f);
+
+  using clock = std::chrono::steady_clock;
+  const int maxSteps = 60 * 60;
+  double totalMs = 0.;
+  double worstMs = 0.;
+  int steps = 0;
+  for (; steps < maxSteps && world.getAwakeCount() > 0; steps++) {
+    auto begin = clock::now();
+    world.step();
+    double ms =
+        std::chrono::duration<double, std::milli>(clock::now() - begin).count();
+    totalMs += ms;
+    worstMs = std::max(worstMs, ms);
+    if (steps % 60 == 0)
+      std::println("t={:5.1f}s awake={:6} step={:.3f}ms",
+                   steps * vkh::PhysicsWorld::fixedDt, world.getAwakeCount(),
+                   ms);
+  }
+
+  std::println("{} crates, {} steps ({:.1f}s simulated)", crateCount, steps,
+               steps * vkh::PhysicsWorld::fixedDt);
+  std::println("avg step {:.3f}ms, worst {:.3f}ms, total {:.1f}ms",
+               totalMs / std::max(steps, 1), worstMs, totalMs);
+
+  // Once asleep the world should cost nothing
+  auto begin = clock::now();
+  for (int i = 0; i < 600; i++)
+    world.step();
+  std::println("600 steps at rest: {:.3f}ms",
+               std::chrono::duration<double, std::milli>(clock::now() - begin)
+                   .count());
+  return world.getAwakeCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
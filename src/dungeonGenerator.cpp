@@ -7,7 +7,9 @@
 #include "vkh/scene.hpp"
 #include "vkh/systems/entity/entities.hpp"
 
+#include <array>
 #include <bitset>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <stack>
@@ -77,7 +79,102 @@ enum Tile {
   Wall_W = 5,
 };
 
-enum Direction { North, East, South, West };
+// Indexed binary min-heap of the cells still to collapse, ordered by entropy
+// with ties broken by a random key drawn once per attempt. A cell only moves
+// when propagation shrinks it, so picking the next cell to observe costs a
+// pop instead of a scan of the whole grid.
+class EntropyHeap {
+public:
+  static constexpr size_t npos = SIZE_MAX;
+
+  void reset(size_t cellCount, size_t entropy) {
+    heap.resize(cellCount);
+    positions.resize(cellCount);
+    entropies.assign(cellCount, entropy);
+    tiebreaks.resize(cellCount);
+    for (size_t i = 0; i < cellCount; i++) {
+      heap[i] = i;
+      positions[i] = i;
+      tiebreaks[i] = static_cast<uint32_t>(rng());
+    }
+    for (size_t i = cellCount / 2; i-- > 0;)
+      siftDown(i);
+  }
+
+  bool empty() const { return heap.empty(); }
+  size_t top() const { return heap.front(); }
+
+  // Inserts the cell if it isn't queued yet
+  void update(size_t cell, size_t entropy) {
+    entropies[cell] = entropy;
+    if (positions[cell] == npos) {
+      positions[cell] = heap.size();
+      heap.push_back(cell);
+    }
+    siftDown(siftUp(positions[cell]));
+  }
+
+  void remove(size_t cell) {
+    size_t position = positions[cell];
+    if (position == npos)
+      return;
+    positions[cell] = npos;
+    size_t last = heap.back();
+    heap.pop_back();
+    if (position == heap.size())
+      return;
+    heap[position] = last;
+    positions[last] = position;
+    siftDown(siftUp(position));
+  }
+
+private:
+  bool less(size_t a, size_t b) const {
+    if (entropies[a] != entropies[b])
+      return entropies[a] < entropies[b];
+    return tiebreaks[a] < tiebreaks[b];
+  }
+
+  void place(size_t position, size_t cell) {
+    heap[position] = cell;
+    positions[cell] = position;
+  }
+
+  size_t siftUp(size_t position) {
+    size_t cell = heap[position];
+    while (position > 0) {
+      size_t parent = (position - 1) / 2;
+      if (!less(cell, heap[parent]))
+        break;
+      place(position, heap[parent]);
+      position = parent;
+    }
+    place(position, cell);
+    return position;
+  }
+
+  size_t siftDown(size_t position) {
+    size_t cell = heap[position];
+    while (true) {
+      size_t child = position * 2 + 1;
+      if (child >= heap.size())
+        break;
+      if (child + 1 < heap.size() && less(heap[child + 1], heap[child]))
+        child++;
+      if (!less(heap[child], cell))
+        break;
+      place(position, heap[child]);
+      position = child;
+    }
+    place(position, cell);
+    return position;
+  }
+
+  std::vector<size_t> heap;
+  std::vector<size_t> positions; // npos when the cell isn't queued
+  std::vector<size_t> entropies;
+  std::vector<uint32_t> tiebreaks;
+};
 
 struct WFC {
   static constexpr size_t TilePossibilitiesCount =
@@ -85,10 +182,38 @@ struct WFC {
   using TilePossibilities = std::bitset<TilePossibilitiesCount>;
   std::vector<TilePossibilities> grid;
   std::stack<size_t> stack;
+  EntropyHeap entropyHeap;
   size_t N{};
   size_t NSquared{};
 
-  WFC(size_t N) : N{N}, NSquared{N * N} {
+  // Every change made during the attempt as (cell, possibilities before), a
+  // contradiction rolls back to the last decision instead of starting over.
+  // Each entry strictly shrinks a cell, so it never outgrows NSquared times
+  // the tile count.
+  std::vector<std::pair<size_t, TilePossibilities>> trail;
+  struct Decision {
+    size_t cell;
+    size_t trailSize; // Trail size before the cell was collapsed
+    size_t tile;
+  };
+  std::vector<Decision> decisions;
+  // Per attempt, past that runWithRetries starts over with a fresh grid
+  size_t maxBacktracks{};
+  size_t backtracks{};
+
+  // compatible[dir][tile] is the set of tiles that can sit next to tile in
+  // direction dir
+  std::array<std::array<TilePossibilities, TilePossibilitiesCount>, 4>
+      compatible;
+
+  WFC(size_t N) : N{N}, NSquared{N * N}, maxBacktracks{N * N} {
+    for (int dir = 0; dir < 4; dir++)
+      for (size_t self = 0; self < TilePossibilitiesCount; self++)
+        for (size_t neighbor = 0; neighbor < TilePossibilitiesCount;
+             neighbor++)
+          compatible[dir][self][neighbor] = adjacencyConstraint(
+              static_cast<Tile>(self), static_cast<Tile>(neighbor),
+              static_cast<Direction>(dir));
     grid.resize(NSquared);
     reset();
   }
@@ -98,6 +223,55 @@ struct WFC {
       cell.set();
     while (!stack.empty())
       stack.pop();
+    entropyHeap.reset(NSquared, TilePossibilitiesCount);
+    trail.clear();
+    decisions.clear();
+    backtracks = 0;
+  }
+
+  void setPossibilities(size_t idx, TilePossibilities possibilities) {
+    grid[idx] = possibilities;
+    size_t entropy = possibilities.count();
+    if (entropy > 1)
+      entropyHeap.update(idx, entropy);
+    else
+      entropyHeap.remove(idx);
+  }
+
+  void assign(size_t idx, TilePossibilities possibilities) {
+    trail.emplace_back(idx, grid[idx]);
+    setPossibilities(idx, possibilities);
+  }
+
+  void rollback(size_t trailSize) {
+    while (trail.size() > trailSize) {
+      auto [idx, possibilities] = trail.back();
+      trail.pop_back();
+      setPossibilities(idx, possibilities);
+    }
+  }
+
+  // Undoes decisions until one can be banned without contradiction, false
+  // once there's nothing left to undo or the budget is spent
+  bool backtrack() {
+    while (!decisions.empty() && backtracks < maxBacktracks) {
+      backtracks++;
+      Decision decision = decisions.back();
+      decisions.pop_back();
+      rollback(decision.trailSize);
+      while (!stack.empty())
+        stack.pop();
+
+      TilePossibilities remaining = grid[decision.cell];
+      remaining.reset(decision.tile);
+      if (remaining.none())
+        continue;
+      assign(decision.cell, remaining);
+      stack.push(decision.cell);
+      if (propagatePossibilities())
+        return true;
+    }
+    return false;
   }
 
   size_t getIdx(glm::ivec2 pos) { return pos.y * N + pos.x; }
@@ -106,7 +280,7 @@ struct WFC {
     return glm::ivec2(static_cast<int>(idx % N), static_cast<int>(idx / N));
   }
 
-  bool adjacencyConstraint(Tile self, Tile neighbor, Direction dir) {
+  static bool adjacencyConstraint(Tile self, Tile neighbor, Direction dir) {
     auto getEdge = [](Tile t, Direction d) -> bool {
       if (t == Floor)
         return true;
@@ -124,37 +298,16 @@ struct WFC {
       return false;
     };
 
-    Direction opposite;
-    if (dir == North)
-      opposite = South;
-    else if (dir == South)
-      opposite = North;
-    else if (dir == East)
-      opposite = West;
-    else if (dir == West)
-      opposite = East;
-
-    return getEdge(self, dir) == getEdge(neighbor, opposite);
+    return getEdge(self, dir) == getEdge(neighbor, opposite(dir));
   }
 
   std::optional<size_t> observe() {
     std::optional<size_t> bestCellIdx{};
-    size_t minEntropy = TilePossibilitiesCount + 1;
-
-    for (size_t i = 0; i < NSquared; i++) {
-      size_t entropy = grid[i].count();
-      if (entropy > 1) {
-        if (entropy < minEntropy ||
-            (entropy == minEntropy &&
-             std::uniform_int_distribution<>(0, 1)(rng) == 0)) {
-          minEntropy = entropy;
-          bestCellIdx = i;
-        }
-      }
-    }
+    if (!entropyHeap.empty())
+      bestCellIdx = entropyHeap.top();
 
     if (bestCellIdx.has_value()) {
-      TilePossibilities &cell = grid[bestCellIdx.value()];
+      const TilePossibilities &cell = grid[bestCellIdx.value()];
       std::vector<size_t> validIndices;
 
       for (int i = 0; i < TilePossibilitiesCount; ++i) {
@@ -172,8 +325,9 @@ struct WFC {
 
       int chosenIndex = validIndices[std::uniform_int_distribution<>(
           0, validIndices.size() - 1)(rng)];
-      cell.reset();
-      cell.set(chosenIndex);
+      decisions.push_back(
+          {bestCellIdx.value(), trail.size(), static_cast<size_t>(chosenIndex)});
+      assign(bestCellIdx.value(), TilePossibilities{}.set(chosenIndex));
 
       stack.push(bestCellIdx.value());
     }
@@ -182,58 +336,41 @@ struct WFC {
 
   // false if contradiction is detected
   bool propagatePossibilities() {
-    constexpr std::array<glm::ivec2, 4> dirs = {
-        glm::ivec2{0, 1}, glm::ivec2{1, 0}, glm::ivec2{0, -1},
-        glm::ivec2{-1, 0}};
-    const std::array<Direction, 4> enumDirs = {North, East, South, West};
-
     while (!stack.empty()) {
       size_t idx = stack.top();
       stack.pop();
 
       glm::ivec2 pos = getPos(idx);
-      TilePossibilities &currentPossibilities = grid[idx];
+      const TilePossibilities &currentPossibilities = grid[idx];
+
+      // Everything the neighbors may still be, per direction, whatever this
+      // cell ends up being
+      std::array<TilePossibilities, 4> allowed{};
+      for (size_t curr = 0; curr < TilePossibilitiesCount; curr++)
+        if (currentPossibilities.test(curr))
+          for (size_t i = 0; i < 4; i++)
+            allowed[i] |= compatible[i][curr];
 
       for (size_t i = 0; i < 4; i++) {
-        glm::ivec2 neighborPos = pos + dirs[i];
+        glm::ivec2 neighborPos = pos + directionOffsets[i];
         if (neighborPos.x < 0 || neighborPos.x >= (int)N || neighborPos.y < 0 ||
             neighborPos.y >= (int)N) {
           continue;
         }
 
         size_t neighborIdx = getIdx(neighborPos);
-        TilePossibilities &neighborPossibilities = grid[neighborIdx];
+        const TilePossibilities &neighborPossibilities = grid[neighborIdx];
 
-        if (neighborPossibilities.count() <= 1)
-          continue;
-
-        bool neighborChanged = false;
-        for (size_t next = 0; next < TilePossibilitiesCount; next++) {
-          if (!neighborPossibilities.test(next))
-            continue;
-
-          bool possible = false;
-          for (size_t curr = 0; curr < TilePossibilitiesCount; curr++) {
-            if (currentPossibilities.test(curr)) {
-              if (adjacencyConstraint(static_cast<Tile>(curr),
-                                      static_cast<Tile>(next), enumDirs[i])) {
-                possible = true;
-                break;
-              }
-            }
-          }
-          if (!possible) {
-            neighborPossibilities.reset(next);
-            neighborChanged = true;
-
-            // contradiction
-            if (neighborPossibilities.none()) {
-              return false;
-            }
+        TilePossibilities narrowed = neighborPossibilities & allowed[i];
+        if (narrowed != neighborPossibilities) {
+          // contradiction
+          if (narrowed.none()) {
+            return false;
           }
-        }
-        if (neighborChanged)
+
+          assign(neighborIdx, narrowed);
           stack.push(neighborIdx);
+        }
       }
     }
     return true;
@@ -260,8 +397,9 @@ struct WFC {
         return true; // We successfully collapsed the whole grid!
       }
 
-      if (!propagatePossibilities()) {
-        return false; // Contradiction during generation
+      // Contradiction during generation, undo the latest decisions
+      if (!propagatePossibilities() && !backtrack()) {
+        return false;
       }
     }
   }
@@ -270,7 +408,8 @@ struct WFC {
     for (int i = 0; i < maxRetries; ++i) {
       reset();
       if (runAttempt()) {
-        std::cout << "WFC Success after " << i << " retries.\n";
+        std::cout << "WFC Success after " << i << " retries and "
+                  << backtracks << " backtracks.\n";
         return;
       }
     }
@@ -279,13 +418,34 @@ struct WFC {
   }
 };
 
-void generateDungeon(vkh::EngineContext &context, vkh::EntitySys &entitySys) {
+// Sides of the tile that aren't closed by a wall
+static uint8_t openSides(Tile t) {
+  switch (t) {
+  case Floor:
+    return 0b1111;
+  case Wall_N:
+    return 0b1111 & ~(1 << North);
+  case Wall_E:
+    return 0b1111 & ~(1 << East);
+  case Wall_S:
+    return 0b1111 & ~(1 << South);
+  case Wall_W:
+    return 0b1111 & ~(1 << West);
+  default:
+    return 0;
+  }
+}
+
+DungeonGrid generateDungeon(vkh::EngineContext &context,
+                            vkh::EntitySys &entitySys) {
   auto assets = std::make_shared<vkh::Scene<vkh::EntitySys::Vertex>>(
       context, "models/dungeonAssets.glb", entitySys.texturesSetLayout);
 
   WFC wfc(15);
   wfc.runWithRetries(50);
 
+  DungeonGrid grid({static_cast<int>(wfc.N), static_cast<int>(wfc.N)});
+
   for (size_t i = 0; i < wfc.NSquared; ++i) {
     Tile t = Empty;
     for (size_t b = 0; b < wfc.TilePossibilitiesCount; ++b) {
@@ -295,6 +455,8 @@ void generateDungeon(vkh::EngineContext &context, vkh::EntitySys &entitySys) {
       }
     }
 
+    grid.setCell(wfc.getPos(i), openSides(t));
+
     if (t == Empty)
       continue;
 
@@ -347,4 +509,5 @@ void generateDungeon(vkh::EngineContext &context, vkh::EntitySys &entitySys) {
     }
   }
   entitySys.markStructuralDirty();
+  return grid;
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "dungeonGrid.hpp"
 #include "vkh/engineContext.hpp"
 #include "vkh/systems/entity/entities.hpp"
 
-void generateDungeon(vkh::EngineContext &context, vkh::EntitySys &entitySys);
+// Spawns the dungeon entities and returns the tile grid they were built from
+DungeonGrid generateDungeon(vkh::EngineContext &context,
+                            vkh::EntitySys &entitySys);
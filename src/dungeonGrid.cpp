@@ -0,0 +1,80 @@
+#include "dungeonGrid.hpp"
+
+#include <cmath>
+#include <limits>
+
+DungeonGrid::DungeonGrid(glm::ivec2 size, float tileSize, glm::vec2 origin)
+    : size{size}, tileSize{tileSize}, origin{origin},
+      cells(static_cast<size_t>(size.x) * size.y, 0) {}
+
+void DungeonGrid::bakeCell(glm::ivec2 cell) {
+  uint8_t &data = cells[index(cell)];
+  uint8_t passable = 0;
+  for (int d = 0; d < 4; d++) {
+    if (!(data & (1 << d)))
+      continue;
+    glm::ivec2 neighbor = cell + directionOffsets[d];
+    if (!inBounds(neighbor))
+      continue;
+    if (cells[index(neighbor)] & (1 << opposite(static_cast<Direction>(d))))
+      passable |= 1 << d;
+  }
+  data = (data & 0x0F) | passable << 4;
+}
+
+void DungeonGrid::setCell(glm::ivec2 cell, uint8_t openSides) {
+  if (!inBounds(cell))
+    return;
+  uint8_t &data = cells[index(cell)];
+  data = (data & 0xF0) | (openSides & 0x0F);
+  bakeCell(cell);
+  for (const auto &offset : directionOffsets)
+    if (inBounds(cell + offset))
+      bakeCell(cell + offset);
+}
+
+std::optional<DungeonGrid::RaycastHit>
+DungeonGrid::raycast(glm::vec3 from, glm::vec3 to) const {
+  const glm::vec2 start = (glm::vec2{from.x, from.z} - origin) / tileSize;
+  const glm::vec2 delta = (glm::vec2{to.x, to.z} - origin) / tileSize - start;
+
+  glm::ivec2 cell = glm::ivec2(glm::floor(start));
+  if (isSolid(cell))
+    return RaycastHit{0.f, cell, North};
+  const glm::ivec2 endCell = glm::ivec2(glm::floor(start + delta));
+
+  glm::ivec2 step{0};
+  glm::vec2 tMax{std::numeric_limits<float>::max()};
+  glm::vec2 tDelta{std::numeric_limits<float>::max()};
+  for (int a = 0; a < 2; a++) {
+    if (delta[a] > 0.f) {
+      step[a] = 1;
+      tMax[a] = (std::floor(start[a]) + 1.f - start[a]) / delta[a];
+      tDelta[a] = 1.f / delta[a];
+    } else if (delta[a] < 0.f) {
+      step[a] = -1;
+      tMax[a] = (std::floor(start[a]) - start[a]) / delta[a];
+      tDelta[a] = -1.f / delta[a];
+    }
+  }
+
+  const glm::ivec2 span = glm::abs(endCell - cell);
+  for (int i = 0; i < span.x + span.y; i++) {
+    const int axis = tMax.x < tMax.y ? 0 : 1;
+    if (tMax[axis] > 1.f)
+      break;
+
+    Direction dir;
+    if (axis == 0)
+      dir = step.x > 0 ? East : West;
+    else
+      dir = step.y > 0 ? North : South;
+
+    if (isEdgeBlocked(cell, dir))
+      return RaycastHit{tMax[axis], cell, dir};
+
+    cell[axis] += step[axis];
+    tMax[axis] += tDelta[axis];
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// North is +y on the grid, which is +z in the world
+enum Direction { North, East, South, West };
+
+inline Direction opposite(Direction dir) {
+  return static_cast<Direction>((dir + 2) % 4);
+}
+
+constexpr std::array<glm::ivec2, 4> directionOffsets = {
+    glm::ivec2{0, 1}, glm::ivec2{1, 0}, glm::ivec2{0, -1}, glm::ivec2{-1, 0}};
+
+// Compact occupancy and edge grid baked from the WFC output, one byte per
+// tile: the low nibble holds the sides the tile itself leaves open, the high
+// nibble the sides that can actually be crossed once the neighbor is taken
+// into account. The high nibble is the navigation graph, so every query is a
+// couple of lookups. A tile open on no side at all is solid rock.
+class DungeonGrid {
+public:
+  DungeonGrid() = default;
+  // origin is the world xz corner of cell (0, 0)
+  DungeonGrid(glm::ivec2 size, float tileSize = 2.f,
+              glm::vec2 origin = glm::vec2{-1.f});
+
+  // Bit d of openSides set when the tile doesn't close side d, the crossable
+  // edges of the cell and its neighbors are rebaked right away
+  void setCell(glm::ivec2 cell, uint8_t openSides);
+
+  bool inBounds(glm::ivec2 cell) const {
+    return cell.x >= 0 && cell.y >= 0 && cell.x < size.x && cell.y < size.y;
+  }
+  bool isSolid(glm::ivec2 cell) const {
+    return !inBounds(cell) || (cells[index(cell)] & 0x0F) == 0;
+  }
+  bool isEdgeBlocked(glm::ivec2 cell, Direction dir) const {
+    return !(getPassableEdges(cell) & (1 << dir));
+  }
+  // Bit d set when one can walk from the cell to its neighbor in direction d
+  uint8_t getPassableEdges(glm::ivec2 cell) const {
+    return inBounds(cell) ? cells[index(cell)] >> 4 : 0;
+  }
+
+  glm::ivec2 worldToCell(glm::vec3 position) const {
+    return glm::ivec2(glm::floor(
+        (glm::vec2{position.x, position.z} - origin) / tileSize));
+  }
+  glm::vec3 cellToWorld(glm::ivec2 cell) const {
+    glm::vec2 center = origin + (glm::vec2(cell) + .5f) * tileSize;
+    return {center.x, 0.f, center.y};
+  }
+
+  struct RaycastHit {
+    float time; // Fraction of from -> to travelled, in [0, 1]
+    glm::ivec2 cell;
+    Direction side; // Side of cell that stopped the ray
+  };
+
+  // DDA walk on the xz plane from -> to, stops at the first edge that can't
+  // be crossed
+  std::optional<RaycastHit> raycast(glm::vec3 from, glm::vec3 to) const;
+  bool lineOfSight(glm::vec3 from, glm::vec3 to) const {
+    return !raycast(from, to).has_value();
+  }
+
+  glm::ivec2 getSize() const { return size; }
+  float getTileSize() const { return tileSize; }
+  glm::vec2 getOrigin() const { return origin; }
+
+private:
+  size_t index(glm::ivec2 cell) const {
+    return static_cast<size_t>(cell.y) * size.x + cell.x;
+  }
+  void bakeCell(glm::ivec2 cell);
+
+  glm::ivec2 size{0};
+  float tileSize{2.f};
+  glm::vec2 origin{-1.f};
+  std::vector<uint8_t> cells;
+};
@@ -6,8 +6,10 @@
 
 FeatherDuckGuard::FeatherDuckGuard(vkh::EngineContext &context,
                                    vkh::EntitySys &entitySys,
-                                   vkh::hud::View &view)
-    : context{context} {
+                                   vkh::hud::View &view,
+                                   Pathfinder &pathfinder)
+    : context{context}, entitySys{entitySys}, pathfinder{pathfinder},
+      pathAgent{pathfinder.createAgent()} {
   headline = view.container.addChild<UI::Text>(
       glm::vec2{0.f, .5f}, "Feather Duck Guard", glm::vec3{0.f}, 3.f);
 
@@ -50,6 +52,46 @@ void FeatherDuckGuard::update() {
 
   if (!targetPositionPtr)
     return;
-  setPosition(glm::normalize(*targetPositionPtr - getPosition()) *
-              context.frameInfo.dt);
+  followTarget();
+}
+
+void FeatherDuckGuard::followTarget() {
+  const glm::vec3 target = *targetPositionPtr;
+  if (!hasRequestedPath || context.time - lastPathRequest > repathInterval ||
+      glm::length(target - requestedGoal) > repathDistance) {
+    pathfinder.requestPath(pathAgent, getPosition(), target);
+    hasRequestedPath = true;
+    requestedGoal = target;
+    lastPathRequest = context.time;
+  }
+
+  const Pathfinder::Path &path = pathfinder.getPath(pathAgent);
+  if (path.version != pathVersion) {
+    pathVersion = path.version;
+    nextWaypoint = 0;
+  }
+
+  glm::vec3 position = getPosition();
+  glm::vec3 destination = target;
+  if (path.version != 0) {
+    // Served but unreachable, wait for the next request instead of walking
+    // into a wall
+    if (!path.found)
+      return;
+    auto groundDistance = [&](glm::vec3 point) {
+      return glm::length(glm::vec2{point.x - position.x, point.z - position.z});
+    };
+    while (nextWaypoint < path.waypoints.size() &&
+           groundDistance(path.waypoints[nextWaypoint]) < waypointRadius)
+      nextWaypoint++;
+    if (nextWaypoint < path.waypoints.size()) {
+      destination = path.waypoints[nextWaypoint];
+      destination.y = position.y;
+    }
+  }
+
+  glm::vec3 toDestination = destination - position;
+  if (glm::length(toDestination) > waypointRadius * .1f)
+    setPosition(position + glm::normalize(toDestination) * speed *
+                               context.frameInfo.dt);
 }
@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 
+#include "../../pathfinding.hpp"
 #include "../../vkh/systems/entity/entities.hpp"
 
 namespace vkh {
@@ -20,7 +21,7 @@ class Text;
 class FeatherDuckGuard {
 public:
   FeatherDuckGuard(vkh::EngineContext &context, vkh::EntitySys &entitySys,
-                   vkh::hud::View &view);
+                   vkh::hud::View &view, Pathfinder &pathfinder);
 
   void flee();
   void aggress();
@@ -41,6 +42,8 @@ private:
   std::vector<std::reference_wrapper<vkh::EntitySys::Entity>> sceneEntities;
 
   vkh::EngineContext &context;
+  vkh::EntitySys &entitySys;
+  Pathfinder &pathfinder;
 
   const glm::vec3 &getPosition() const {
     return sceneEntities[0].get().transform.position;
@@ -48,6 +51,7 @@ private:
   void setPosition(glm::vec3 newPosition) {
     for (auto &entity : sceneEntities) {
       entity.get().transform.position = newPosition;
+      entitySys.markInstanceDirty(&entity.get() - entitySys.entities.data());
     }
   }
 
@@ -56,5 +60,19 @@ private:
   glm::vec3 *targetPositionPtr; // is a pointer so it can track automatically
                                 // the player position for example
 
+  static constexpr float speed = 1.f;
+  // Paths are asked again once the target moved that far or got that old
+  static constexpr float repathDistance = 1.f;
+  static constexpr float repathInterval = 1.f;
+  static constexpr float waypointRadius = .25f;
+
+  Pathfinder::AgentId pathAgent;
+  uint32_t pathVersion = 0;
+  size_t nextWaypoint = 0;
+  bool hasRequestedPath = false;
+  glm::vec3 requestedGoal;
+  float lastPathRequest;
+
   void playAnimation(AnimationIndex index);
+  void followTarget();
 };
@@ -7,6 +7,7 @@
 #include "vkh/audio.hpp"
 #include "vkh/camera.hpp"
 #include "vkh/cleanup.hpp"
+#include "vkh/collisionWorld.hpp"
 #include "vkh/engineContext.hpp"
 #include "vkh/exepath.hpp"
 #include "vkh/init.hpp"
@@ -17,6 +18,7 @@
 #include "vkh/systems/hud/hud.hpp"
 #include "vkh/systems/hud/view.hpp"
 #include "vkh/systems/particles.hpp"
+#include "vkh/systems/physics/physics.hpp"
 #include "vkh/systems/skybox.hpp"
 #include "vkh/systems/smoke/smoke.hpp"
 #include "vkh/systems/water/water.hpp"
@@ -34,6 +36,7 @@
 #include "../server/packet.hpp"
 #include "dungeonGenerator.hpp"
 #include "network.hpp"
+#include "pathfinding.hpp"
 
 #include <chrono>
 #include <random>
@@ -125,7 +128,11 @@ void run() {
     vkh::ParticleSys particleSys(context);
 
     auto &entities = entitySys.entities;
-    generateDungeon(context, entitySys);
+    DungeonGrid dungeonGrid = generateDungeon(context, entitySys);
+    vkh::CollisionWorld collisionWorld;
+    collisionWorld.rebuild(entities);
+    vkh::PhysicsSys physicsSys(context, entitySys, collisionWorld);
+    Pathfinder pathfinder(dungeonGrid);
     // auto piano = std::make_shared<vkh::Scene<vkh::EntitySys::Vertex>>(
     //     context, "models/piano-decent.glb", entitySys.texturesSetLayout);
     // for (size_t i = 0; i < piano->meshes.size(); i++)
@@ -188,7 +195,8 @@ void run() {
     // }
     // worldView.container.addChild<vkh::hud::Polygon>(vertices, 0);
 
-    // FeatherDuckGuard featherDuckGuard(context, entitySys, worldView);
+    // FeatherDuckGuard featherDuckGuard(context, entitySys, worldView,
+    //                                   pathfinder);
 
     auto canvas = canvasView.container.addChild<UI::Canvas>(glm::vec2{},
                                                             glm::vec2{1.f}, 0);
@@ -493,9 +501,9 @@ void run() {
 
       currentTime = newTime;
 
-      // Disable collisions with entities by providing empty array
-      std::vector<vkh::EntitySys::Entity> empty;
-      vkh::input::update(context, empty);
+      vkh::input::update(context, collisionWorld);
+      physicsSys.update();
+      pathfinder.update();
 
       // Entity picking visualization
       {
@@ -503,6 +511,7 @@ void run() {
         if (pointed != lastPicked) {
           if (lastPicked) {
             lastPicked->color = glm::vec4(1.0f); // Reset
+            entitySys.markInstanceDirty(lastPicked - entities.data());
           }
 
           lastPicked = pointed;
@@ -510,6 +519,7 @@ void run() {
           if (lastPicked) {
             lastPicked->color =
                 glm::vec4(2.0f, 0.5f, 0.5f, 1.0f); // Highlight Red-ish
+            entitySys.markInstanceDirty(lastPicked - entities.data());
           }
         }
       }
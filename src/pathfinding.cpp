@@ -0,0 +1,387 @@
+#include "pathfinding.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <queue>
+
+Pathfinder::Pathfinder(const DungeonGrid &grid, size_t queriesPerFrame)
+    : grid{grid}, queriesPerFrame{queriesPerFrame},
+      clusterCount{(grid.getSize() + clusterSize - 1) / clusterSize} {
+  const int count = clusterCount.x * clusterCount.y;
+  clusterNodes.resize(count);
+  borderNodes.resize(static_cast<size_t>(count) * 2);
+  for (int c = 0; c < count; c++) {
+    buildBorder(c, East);
+    buildBorder(c, North);
+  }
+  for (int c = 0; c < count; c++)
+    buildIntraEdges(c);
+}
+
+Pathfinder::AgentId Pathfinder::createAgent() {
+  paths.emplace_back();
+  pending.push_back(0);
+  pendingRequests.emplace_back();
+  return static_cast<AgentId>(paths.size() - 1);
+}
+
+uint32_t Pathfinder::addNode(glm::ivec2 cell) {
+  uint32_t id;
+  if (!freeNodes.empty()) {
+    id = freeNodes.back();
+    freeNodes.pop_back();
+  } else {
+    id = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+  }
+  nodes[id] = Node{cell, clusterOf(cell), true, {}};
+  clusterNodes[nodes[id].cluster].push_back(id);
+  return id;
+}
+
+void Pathfinder::clearBorder(size_t border) {
+  for (uint32_t id : borderNodes[border]) {
+    auto &list = clusterNodes[nodes[id].cluster];
+    list.erase(std::find(list.begin(), list.end(), id));
+    nodes[id].alive = false;
+    nodes[id].edges.clear();
+    freeNodes.push_back(id);
+  }
+  borderNodes[border].clear();
+}
+
+void Pathfinder::buildBorder(int cluster, Direction dir) {
+  const glm::ivec2 min = clusterMin(cluster);
+  const glm::ivec2 size = grid.getSize();
+  const int axis = dir == East ? 0 : 1; // Axis crossed by the border
+  const int along = 1 - axis;
+  if (min[axis] + clusterSize >= size[axis])
+    return;
+
+  auto &border = borderNodes[cluster * 2 + (dir == East ? 0 : 1)];
+  const int end = std::min(min[along] + clusterSize, size[along]);
+
+  // Every run of crossable edges along the border is one entrance, placed at
+  // the middle of the run
+  auto addEntrance = [&](int first, int last) {
+    glm::ivec2 inside;
+    inside[axis] = min[axis] + clusterSize - 1;
+    inside[along] = (first + last) / 2;
+    uint32_t a = addNode(inside);
+    uint32_t b = addNode(inside + directionOffsets[dir]);
+    nodes[a].edges.push_back({b, 1.f, true});
+    nodes[b].edges.push_back({a, 1.f, true});
+    border.push_back(a);
+    border.push_back(b);
+  };
+
+  int runStart = -1;
+  for (int i = min[along]; i < end; i++) {
+    glm::ivec2 cell;
+    cell[axis] = min[axis] + clusterSize - 1;
+    cell[along] = i;
+    bool open = !grid.isEdgeBlocked(cell, dir);
+    if (open && runStart < 0)
+      runStart = i;
+    if (!open && runStart >= 0) {
+      addEntrance(runStart, i - 1);
+      runStart = -1;
+    }
+  }
+  if (runStart >= 0)
+    addEntrance(runStart, end - 1);
+}
+
+void Pathfinder::floodCluster(int cluster, glm::ivec2 from,
+                              std::vector<int> &distances) const {
+  const glm::ivec2 min = clusterMin(cluster);
+  const glm::ivec2 max = glm::min(min + clusterSize, grid.getSize());
+  distances.assign(clusterSize * clusterSize, -1);
+
+  auto local = [&](glm::ivec2 cell) {
+    return (cell.y - min.y) * clusterSize + cell.x - min.x;
+  };
+
+  std::vector<glm::ivec2> frontier{from};
+  distances[local(from)] = 0;
+  for (size_t head = 0; head < frontier.size(); head++) {
+    const glm::ivec2 cell = frontier[head];
+    const uint8_t edges = grid.getPassableEdges(cell);
+    for (int d = 0; d < 4; d++) {
+      if (!(edges & (1 << d)))
+        continue;
+      glm::ivec2 next = cell + directionOffsets[d];
+      if (next.x < min.x || next.y < min.y || next.x >= max.x ||
+          next.y >= max.y || distances[local(next)] >= 0)
+        continue;
+      distances[local(next)] = distances[local(cell)] + 1;
+      frontier.push_back(next);
+    }
+  }
+}
+
+void Pathfinder::buildIntraEdges(int cluster) {
+  const glm::ivec2 min = clusterMin(cluster);
+  std::vector<int> distances;
+  for (uint32_t id : clusterNodes[cluster]) {
+    auto &edges = nodes[id].edges;
+    std::erase_if(edges, [](const Edge &edge) { return !edge.inter; });
+
+    floodCluster(cluster, nodes[id].cell, distances);
+    for (uint32_t other : clusterNodes[cluster]) {
+      if (other == id)
+        continue;
+      glm::ivec2 cell = nodes[other].cell - min;
+      int distance = distances[cell.y * clusterSize + cell.x];
+      if (distance >= 0)
+        edges.push_back({other, static_cast<float>(distance), false});
+    }
+  }
+}
+
+bool Pathfinder::localPath(int cluster, glm::ivec2 from, glm::ivec2 to,
+                           std::vector<glm::ivec2> &cells) const {
+  if (from == to)
+    return true;
+
+  // Flood from the destination, then walk downhill from the start
+  std::vector<int> distances;
+  floodCluster(cluster, to, distances);
+  const glm::ivec2 min = clusterMin(cluster);
+  auto distanceAt = [&](glm::ivec2 cell) {
+    glm::ivec2 local = cell - min;
+    if (local.x < 0 || local.y < 0 || local.x >= clusterSize ||
+        local.y >= clusterSize)
+      return -1;
+    return distances[local.y * clusterSize + local.x];
+  };
+
+  int distance = distanceAt(from);
+  if (distance < 0)
+    return false;
+  glm::ivec2 cell = from;
+  while (distance > 0) {
+    const uint8_t edges = grid.getPassableEdges(cell);
+    for (int d = 0; d < 4; d++) {
+      glm::ivec2 next = cell + directionOffsets[d];
+      if ((edges & (1 << d)) && distanceAt(next) == distance - 1) {
+        cell = next;
+        break;
+      }
+    }
+    distance--;
+    cells.push_back(cell);
+  }
+  return true;
+}
+
+std::optional<std::vector<uint32_t>>
+Pathfinder::abstractSearch(glm::ivec2 from, glm::ivec2 to) {
+  const int startCluster = clusterOf(from);
+  const int goalCluster = clusterOf(to);
+  const glm::ivec2 startMin = clusterMin(startCluster);
+  const glm::ivec2 goalMin = clusterMin(goalCluster);
+
+  // Temporary links from the start and to the goal, only into their clusters
+  std::vector<int> startDistances, goalDistances;
+  floodCluster(startCluster, from, startDistances);
+  floodCluster(goalCluster, to, goalDistances);
+  auto localDistance = [](const std::vector<int> &distances, glm::ivec2 min,
+                          glm::ivec2 cell) {
+    cell -= min;
+    return distances[cell.y * clusterSize + cell.x];
+  };
+
+  const float infinity = std::numeric_limits<float>::max();
+  std::vector<float> cost(nodes.size(), infinity);
+  std::vector<uint32_t> parent(nodes.size(), UINT32_MAX);
+  auto heuristic = [&](glm::ivec2 cell) {
+    glm::ivec2 d = glm::abs(to - cell);
+    return static_cast<float>(d.x + d.y);
+  };
+
+  using Entry = std::pair<float, uint32_t>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+  for (uint32_t id : clusterNodes[startCluster]) {
+    int distance = localDistance(startDistances, startMin, nodes[id].cell);
+    if (distance < 0)
+      continue;
+    cost[id] = static_cast<float>(distance);
+    open.push({cost[id] + heuristic(nodes[id].cell), id});
+  }
+
+  float bestCost = infinity;
+  uint32_t bestLast = UINT32_MAX;
+  while (!open.empty()) {
+    auto [estimate, id] = open.top();
+    open.pop();
+    if (estimate >= bestCost)
+      break;
+    if (estimate > cost[id] + heuristic(nodes[id].cell))
+      continue; // Stale entry
+
+    if (nodes[id].cluster == goalCluster) {
+      int distance = localDistance(goalDistances, goalMin, nodes[id].cell);
+      if (distance >= 0 && cost[id] + distance < bestCost) {
+        bestCost = cost[id] + distance;
+        bestLast = id;
+      }
+    }
+
+    for (const Edge &edge : nodes[id].edges) {
+      float next = cost[id] + edge.cost;
+      if (next >= cost[edge.to])
+        continue;
+      cost[edge.to] = next;
+      parent[edge.to] = id;
+      open.push({next + heuristic(nodes[edge.to].cell), edge.to});
+    }
+  }
+
+  if (bestLast == UINT32_MAX)
+    return std::nullopt;
+  std::vector<uint32_t> route;
+  for (uint32_t id = bestLast; id != UINT32_MAX; id = parent[id])
+    route.push_back(id);
+  std::reverse(route.begin(), route.end());
+  return route;
+}
+
+bool Pathfinder::refine(glm::ivec2 from, glm::ivec2 to,
+                        const std::vector<uint32_t> &route,
+                        std::vector<glm::ivec2> &cells) const {
+  const Node &first = nodes[route.front()];
+  if (!localPath(first.cluster, from, first.cell, cells))
+    return false;
+  for (size_t i = 1; i < route.size(); i++) {
+    const Node &a = nodes[route[i - 1]];
+    const Node &b = nodes[route[i]];
+    if (a.cluster != b.cluster)
+      cells.push_back(b.cell);
+    else if (!localPath(a.cluster, a.cell, b.cell, cells))
+      return false;
+  }
+  const Node &last = nodes[route.back()];
+  return localPath(last.cluster, last.cell, to, cells);
+}
+
+void Pathfinder::serve(const Request &request) {
+  Path &path = paths[request.agent];
+  path.version++;
+  path.waypoints.clear();
+  path.found = false;
+
+  const glm::ivec2 from = grid.worldToCell(request.from);
+  const glm::ivec2 to = grid.worldToCell(request.to);
+  if (grid.isSolid(from) || grid.isSolid(to))
+    return;
+
+  const int startCluster = clusterOf(from);
+  const int goalCluster = clusterOf(to);
+  std::vector<glm::ivec2> cells{from};
+
+  bool found = startCluster == goalCluster &&
+               localPath(startCluster, from, to, cells);
+  if (!found) {
+    // A cached route was searched for other endpoints in the same clusters,
+    // it's reused as long as both ends still connect to it
+    const uint64_t key = routeKey(startCluster, goalCluster);
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      found = refine(from, to, it->second.nodes, cells);
+      if (!found)
+        cells.resize(1);
+    }
+    if (!found) {
+      auto route = abstractSearch(from, to);
+      if (!route)
+        return;
+      found = refine(from, to, *route, cells);
+      if (!found)
+        return;
+
+      CachedRoute cached{std::move(*route), {}};
+      for (uint32_t id : cached.nodes)
+        if (std::find(cached.clusters.begin(), cached.clusters.end(),
+                      nodes[id].cluster) == cached.clusters.end())
+          cached.clusters.push_back(nodes[id].cluster);
+      cache[key] = std::move(cached);
+    }
+  }
+
+  // String pull the cell path, only keep the corners needed to stay in line
+  // of sight of each other
+  std::vector<glm::vec3> &waypoints = path.waypoints;
+  glm::vec3 anchor = grid.cellToWorld(cells.front());
+  for (size_t i = 1; i < cells.size(); i++) {
+    if (i + 1 < cells.size() &&
+        grid.lineOfSight(anchor, grid.cellToWorld(cells[i + 1])))
+      continue;
+    anchor = grid.cellToWorld(cells[i]);
+    waypoints.push_back(anchor);
+  }
+  if (!waypoints.empty()) {
+    // Head straight for the target once in its cell
+    waypoints.back().x = request.to.x;
+    waypoints.back().z = request.to.z;
+  }
+  path.found = true;
+}
+
+void Pathfinder::requestPath(AgentId agent, glm::vec3 from, glm::vec3 to) {
+  pendingRequests[agent] = Request{agent, from, to};
+  if (!pending[agent]) {
+    pending[agent] = 1;
+    queue.push_back({agent, {}, {}});
+  }
+}
+
+void Pathfinder::update() {
+  for (size_t i = 0; i < queriesPerFrame && !queue.empty(); i++) {
+    AgentId agent = queue.front().agent;
+    queue.pop_front();
+    pending[agent] = 0;
+    serve(pendingRequests[agent]);
+  }
+}
+
+void Pathfinder::onTileChanged(glm::ivec2 cell) {
+  if (!grid.inBounds(cell))
+    return;
+
+  // The tile's edges touch its own cluster and possibly the borders shared
+  // with the clusters west and south of it, rebuild all of them
+  const int cluster = clusterOf(cell);
+  const glm::ivec2 coords{cluster % clusterCount.x, cluster / clusterCount.x};
+  std::vector<int> touched{cluster};
+  for (const auto &offset : directionOffsets) {
+    glm::ivec2 neighbor = coords + offset;
+    if (neighbor.x >= 0 && neighbor.y >= 0 && neighbor.x < clusterCount.x &&
+        neighbor.y < clusterCount.y)
+      touched.push_back(neighbor.y * clusterCount.x + neighbor.x);
+  }
+
+  const int west = coords.x > 0 ? cluster - 1 : -1;
+  const int south = coords.y > 0 ? cluster - clusterCount.x : -1;
+  clearBorder(cluster * 2);
+  clearBorder(cluster * 2 + 1);
+  buildBorder(cluster, East);
+  buildBorder(cluster, North);
+  if (west >= 0) {
+    clearBorder(west * 2);
+    buildBorder(west, East);
+  }
+  if (south >= 0) {
+    clearBorder(south * 2 + 1);
+    buildBorder(south, North);
+  }
+  for (int c : touched)
+    buildIntraEdges(c);
+
+  std::erase_if(cache, [&](const auto &entry) {
+    const auto &clusters = entry.second.clusters;
+    return std::any_of(touched.begin(), touched.end(), [&](int c) {
+      return std::find(clusters.begin(), clusters.end(), c) != clusters.end();
+    });
+  });
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "dungeonGrid.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// Hierarchical A* (HPA*) over a DungeonGrid. The grid is cut in square
+// clusters, entrances between neighboring clusters and the distances between
+// entrances of a same cluster are precomputed, so a query searches a small
+// abstract graph and only refines the hops it actually takes. Requests are
+// queued and served within a per frame budget, and abstract routes are cached
+// per (start cluster, goal cluster) so agents chasing the same target mostly
+// hit the cache.
+class Pathfinder {
+public:
+  static constexpr int clusterSize = 8;
+
+  using AgentId = uint32_t;
+
+  struct Path {
+    std::vector<glm::vec3> waypoints; // World space, y is the grid plane
+    uint32_t version = 0;             // Bumped every time the path is served
+    bool found = false;
+  };
+
+  Pathfinder(const DungeonGrid &grid, size_t queriesPerFrame = 4);
+
+  AgentId createAgent();
+
+  // Replaces the agent's pending request if it has one
+  void requestPath(AgentId agent, glm::vec3 from, glm::vec3 to);
+  // Serves at most queriesPerFrame queued requests
+  void update();
+
+  const Path &getPath(AgentId agent) const { return paths[agent]; }
+
+  // Call after DungeonGrid::setCell, only the entrances and distances around
+  // the cell's cluster are rebuilt and only cached routes through it dropped
+  void onTileChanged(glm::ivec2 cell);
+
+  void setQueriesPerFrame(size_t count) { queriesPerFrame = count; }
+  size_t getCacheSize() const { return cache.size(); }
+
+private:
+  struct Edge {
+    uint32_t to;
+    float cost;
+    bool inter; // Crosses into the neighbor cluster
+  };
+  struct Node {
+    glm::ivec2 cell;
+    int cluster;
+    bool alive;
+    std::vector<Edge> edges;
+  };
+  struct Request {
+    AgentId agent;
+    glm::vec3 from;
+    glm::vec3 to;
+  };
+  struct CachedRoute {
+    std::vector<uint32_t> nodes;
+    std::vector<int> clusters;
+  };
+
+  int clusterOf(glm::ivec2 cell) const {
+    return (cell.y / clusterSize) * clusterCount.x + cell.x / clusterSize;
+  }
+  glm::ivec2 clusterMin(int cluster) const {
+    return glm::ivec2{cluster % clusterCount.x, cluster / clusterCount.x} *
+           clusterSize;
+  }
+  static uint64_t routeKey(int startCluster, int goalCluster) {
+    return static_cast<uint64_t>(startCluster) << 32 |
+           static_cast<uint32_t>(goalCluster);
+  }
+
+  uint32_t addNode(glm::ivec2 cell);
+  void clearBorder(size_t border);
+  void buildBorder(int cluster, Direction dir);
+  void buildIntraEdges(int cluster);
+
+  // Breadth first search restricted to one cluster, fills distances to every
+  // reachable cell of it (-1 for unreachable), indexed inside the cluster
+  void floodCluster(int cluster, glm::ivec2 from,
+                    std::vector<int> &distances) const;
+  bool localPath(int cluster, glm::ivec2 from, glm::ivec2 to,
+                 std::vector<glm::ivec2> &cells) const;
+  std::optional<std::vector<uint32_t>> abstractSearch(glm::ivec2 from,
+                                                      glm::ivec2 to);
+  bool refine(glm::ivec2 from, glm::ivec2 to,
+              const std::vector<uint32_t> &route,
+              std::vector<glm::ivec2> &cells) const;
+  void serve(const Request &request);
+
+  const DungeonGrid &grid;
+  size_t queriesPerFrame;
+  glm::ivec2 clusterCount;
+
+  std::vector<Node> nodes;
+  std::vector<uint32_t> freeNodes;
+  std::vector<std::vector<uint32_t>> clusterNodes;
+  // Two borders per cluster, its east one at 2 * cluster and its north one
+  // at 2 * cluster + 1
+  std::vector<std::vector<uint32_t>> borderNodes;
+
+  std::unordered_map<uint64_t, CachedRoute> cache;
+
+  std::deque<Request> queue;
+  std::vector<uint8_t> pending;
+  std::vector<Request> pendingRequests;
+  std::vector<Path> paths;
+};
@@ -0,0 +1,244 @@
+#include "collisionWorld.hpp"
+
+#include <glm/gtx/norm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vkh {
+
+CollisionWorld::CollisionWorld(float cellSize)
+    : cellSize{cellSize}, invCellSize{1.f / cellSize} {}
+
+void CollisionWorld::clear() {
+  bodies.clear();
+  cells.clear();
+  stamps.clear();
+  currentStamp = 0;
+}
+
+void CollisionWorld::link(uint32_t id) {
+  Body &body = bodies[id];
+  body.minCell = cellOf(body.bounds.min);
+  body.maxCell = cellOf(body.bounds.max);
+  for (int x = body.minCell.x; x <= body.maxCell.x; x++)
+    for (int y = body.minCell.y; y <= body.maxCell.y; y++)
+      for (int z = body.minCell.z; z <= body.maxCell.z; z++)
+        cells[key({x, y, z})].push_back(id);
+}
+
+void CollisionWorld::unlink(uint32_t id) {
+  const Body &body = bodies[id];
+  for (int x = body.minCell.x; x <= body.maxCell.x; x++)
+    for (int y = body.minCell.y; y <= body.maxCell.y; y++)
+      for (int z = body.minCell.z; z <= body.maxCell.z; z++) {
+        auto it = cells.find(key({x, y, z}));
+        if (it == cells.end())
+          continue;
+        auto &ids = it->second;
+        auto found = std::find(ids.begin(), ids.end(), id);
+        if (found != ids.end()) {
+          *found = ids.back();
+          ids.pop_back();
+        }
+        if (ids.empty())
+          cells.erase(it);
+      }
+}
+
+void CollisionWorld::insert(uint32_t id, const AABB &bounds) {
+  if (id >= bodies.size()) {
+    bodies.resize(id + 1);
+    stamps.resize(id + 1, 0);
+  }
+  if (bodies[id].alive)
+    unlink(id);
+  bodies[id].bounds = bounds;
+  bodies[id].alive = true;
+  link(id);
+}
+
+void CollisionWorld::remove(uint32_t id) {
+  if (id >= bodies.size() || !bodies[id].alive)
+    return;
+  unlink(id);
+  bodies[id].alive = false;
+}
+
+void CollisionWorld::update(uint32_t id, const AABB &bounds) {
+  if (id >= bodies.size() || !bodies[id].alive) {
+    insert(id, bounds);
+    return;
+  }
+  Body &body = bodies[id];
+  // Moving inside the same cells is the common case, no need to touch the
+  // hash at all then
+  if (cellOf(bounds.min) == body.minCell &&
+      cellOf(bounds.max) == body.maxCell) {
+    body.bounds = bounds;
+    return;
+  }
+  unlink(id);
+  body.bounds = bounds;
+  link(id);
+}
+
+uint32_t CollisionWorld::nextStamp() const {
+  if (++currentStamp == 0) {
+    std::fill(stamps.begin(), stamps.end(), 0);
+    currentStamp = 1;
+  }
+  return currentStamp;
+}
+
+// Box vs box sweep done as a ray against the other box grown by the box half
+// extents
+static std::optional<CollisionWorld::SweepHit>
+sweepAgainst(glm::vec3 origin, glm::vec3 half, glm::vec3 delta,
+             const AABB &other, uint32_t id) {
+  const glm::vec3 min = other.min - half;
+  const glm::vec3 max = other.max + half;
+
+  float tEnter = std::numeric_limits<float>::lowest();
+  float tExit = std::numeric_limits<float>::max();
+  int enterAxis = -1;
+  for (int a = 0; a < 3; a++) {
+    if (delta[a] == 0.f) {
+      // Touching faces don't count, otherwise sliding along a floor would
+      // keep hitting it
+      if (origin[a] <= min[a] || origin[a] >= max[a])
+        return std::nullopt;
+      continue;
+    }
+    float t0 = (min[a] - origin[a]) / delta[a];
+    float t1 = (max[a] - origin[a]) / delta[a];
+    if (t0 > t1)
+      std::swap(t0, t1);
+    if (t0 > tEnter) {
+      tEnter = t0;
+      enterAxis = a;
+    }
+    tExit = std::min(tExit, t1);
+  }
+
+  if (enterAxis < 0 || tEnter >= tExit || tEnter > 1.f || tExit <= 0.f)
+    return std::nullopt;
+  // Started inside, only keep it if it's just float noise around a contact
+  if (tEnter < 0.f) {
+    if (tEnter * std::abs(delta[enterAxis]) < -CollisionWorld::skinWidth)
+      return std::nullopt;
+    tEnter = 0.f;
+  }
+
+  glm::vec3 normal{0.f};
+  normal[enterAxis] = delta[enterAxis] > 0.f ? -1.f : 1.f;
+  return CollisionWorld::SweepHit{tEnter, normal, id};
+}
+
+std::optional<CollisionWorld::SweepHit>
+CollisionWorld::sweep(const AABB &box, glm::vec3 delta) const {
+  const glm::vec3 half = (box.max - box.min) * .5f;
+  const glm::vec3 origin = (box.min + box.max) * .5f;
+  const uint32_t stamp = nextStamp();
+  std::optional<SweepHit> best;
+
+  // Anything the box can touch while its center is inside a cell is
+  // registered in the cells overlapping that cell grown by the half extents
+  auto testCell = [&](glm::ivec3 cell) {
+    const glm::vec3 cellMin = glm::vec3(cell) * cellSize;
+    const glm::ivec3 lo = cellOf(cellMin - half);
+    const glm::ivec3 hi = cellOf(cellMin + cellSize + half);
+    for (int x = lo.x; x <= hi.x; x++)
+      for (int y = lo.y; y <= hi.y; y++)
+        for (int z = lo.z; z <= hi.z; z++) {
+          auto it = cells.find(key({x, y, z}));
+          if (it == cells.end())
+            continue;
+          for (uint32_t id : it->second) {
+            if (stamps[id] == stamp)
+              continue;
+            stamps[id] = stamp;
+            auto hit = sweepAgainst(origin, half, delta, bodies[id].bounds, id);
+            if (hit && (!best || hit->time < best->time))
+              best = hit;
+          }
+        }
+  };
+
+  // 3D DDA along the path of the center
+  glm::ivec3 cell = cellOf(origin);
+  const glm::ivec3 endCell = cellOf(origin + delta);
+  glm::ivec3 step{0};
+  glm::vec3 tMax{std::numeric_limits<float>::max()};
+  glm::vec3 tDelta{std::numeric_limits<float>::max()};
+  for (int a = 0; a < 3; a++) {
+    if (delta[a] > 0.f) {
+      step[a] = 1;
+      tMax[a] = ((cell[a] + 1) * cellSize - origin[a]) / delta[a];
+      tDelta[a] = cellSize / delta[a];
+    } else if (delta[a] < 0.f) {
+      step[a] = -1;
+      tMax[a] = (cell[a] * cellSize - origin[a]) / delta[a];
+      tDelta[a] = -cellSize / delta[a];
+    }
+  }
+
+  const glm::ivec3 span = glm::abs(endCell - cell);
+  const int maxCells = span.x + span.y + span.z + 1;
+  for (int visited = 0; visited < maxCells; visited++) {
+    testCell(cell);
+    if (cell == endCell)
+      break;
+
+    int axis = 0;
+    if (tMax[1] < tMax[axis])
+      axis = 1;
+    if (tMax[2] < tMax[axis])
+      axis = 2;
+    // Cells are visited in order of entry time, nothing past this one can be
+    // hit any earlier
+    if (tMax[axis] > 1.f || (best && best->time <= tMax[axis]))
+      break;
+    cell[axis] += step[axis];
+    tMax[axis] += tDelta[axis];
+  }
+  return best;
+}
+
+glm::vec3 CollisionWorld::slide(const AABB &box, glm::vec3 delta,
+                                int maxIterations) const {
+  glm::vec3 moved{0.f};
+  for (int i = 0; i < maxIterations; i++) {
+    if (glm::length2(delta) <= std::numeric_limits<float>::epsilon() *
+                                   std::numeric_limits<float>::epsilon())
+      break;
+
+    auto hit = sweep(box + moved, delta);
+    if (!hit) {
+      moved += delta;
+      break;
+    }
+
+    // Stop a bit short of the contact so the next sweep doesn't start inside
+    const float length = glm::length(delta);
+    const float t = std::max(0.f, hit->time - skinWidth / length);
+    moved += delta * t;
+
+    // Keep what's left of the move minus the part going into the surface
+    delta *= 1.f - t;
+    delta -= hit->normal * glm::dot(delta, hit->normal);
+  }
+  return moved;
+}
+
+bool CollisionWorld::overlaps(const AABB &aabb) const {
+  bool hit = false;
+  query(aabb, [&](uint32_t, const AABB &bounds) {
+    hit = bounds.intersects(aabb);
+    return hit;
+  });
+  return hit;
+}
+
+} // namespace vkh
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "AxisAlignedBoundingBox.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace vkh {
+
+// Uniform spatial hash over world space AABBs. The default cell size matches
+// the 2 unit dungeon tile so a tile sized body only ever touches a handful of
+// cells and every query costs the same no matter how big the world gets.
+class CollisionWorld {
+public:
+  CollisionWorld(float cellSize = 2.f);
+
+  void clear();
+  void insert(uint32_t id, const AABB &bounds);
+  void remove(uint32_t id);
+  void update(uint32_t id, const AABB &bounds);
+
+  // Feeds the world from anything exposing getWorldAABB(), ids are the
+  // indices in the range (so EntitySys::entities indices map 1:1)
+  template <typename Range> void rebuild(const Range &entities) {
+    clear();
+    uint32_t id = 0;
+    for (const auto &entity : entities)
+      insert(id++, entity.getWorldAABB());
+  }
+
+  bool overlaps(const AABB &aabb) const;
+
+  // Calls fn(id, bounds) once for every body sharing a cell with the region,
+  // fn returns true to stop the query early
+  template <typename Fn> void query(const AABB &region, Fn &&fn) const {
+    const glm::ivec3 minCell = cellOf(region.min);
+    const glm::ivec3 maxCell = cellOf(region.max);
+    const uint32_t stamp = nextStamp();
+    for (int x = minCell.x; x <= maxCell.x; x++)
+      for (int y = minCell.y; y <= maxCell.y; y++)
+        for (int z = minCell.z; z <= maxCell.z; z++) {
+          auto it = cells.find(key({x, y, z}));
+          if (it == cells.end())
+            continue;
+          for (uint32_t id : it->second) {
+            if (stamps[id] == stamp)
+              continue;
+            stamps[id] = stamp;
+            if (fn(id, bodies[id].bounds))
+              return;
+          }
+        }
+  }
+
+  // Broadphase for a box moving by delta: every body the swept volume may
+  // touch
+  template <typename Fn>
+  void querySwept(const AABB &box, glm::vec3 delta, Fn &&fn) const {
+    AABB swept{glm::min(box.min, box.min + delta),
+               glm::max(box.max, box.max + delta)};
+    query(swept, std::forward<Fn>(fn));
+  }
+
+  struct SweepHit {
+    float time; // Fraction of the delta travelled before touching, in [0, 1]
+    glm::vec3 normal;
+    uint32_t id;
+  };
+
+  // Earliest body hit by box moving by delta. Only walks the cells crossed by
+  // the sweep so the cost doesn't depend on the size of the world nor on how
+  // far the box moves in one go. Bodies already overlapping the box at the
+  // start are ignored so something stuck can always move out.
+  std::optional<SweepHit> sweep(const AABB &box, glm::vec3 delta) const;
+
+  // Moves box by delta, sliding along whatever it hits, returns the
+  // displacement that can actually be applied
+  glm::vec3 slide(const AABB &box, glm::vec3 delta,
+                  int maxIterations = 4) const;
+
+  // Distance kept between a sliding box and what it touches
+  static constexpr float skinWidth = 1e-3f;
+
+  const AABB &getBounds(uint32_t id) const { return bodies[id].bounds; }
+  float getCellSize() const { return cellSize; }
+
+private:
+  struct Body {
+    AABB bounds;
+    glm::ivec3 minCell;
+    glm::ivec3 maxCell;
+    bool alive = false;
+  };
+
+  glm::ivec3 cellOf(glm::vec3 p) const {
+    return glm::ivec3(glm::floor(p * invCellSize));
+  }
+  static uint64_t key(glm::ivec3 cell) {
+    constexpr uint64_t mask = (1ull << 21) - 1;
+    return (static_cast<uint64_t>(cell.x) & mask) << 42 |
+           (static_cast<uint64_t>(cell.y) & mask) << 21 |
+           (static_cast<uint64_t>(cell.z) & mask);
+  }
+  uint32_t nextStamp() const;
+
+  void link(uint32_t id);
+  void unlink(uint32_t id);
+
+  float cellSize;
+  float invCellSize;
+  std::vector<Body> bodies;
+  std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+
+  // Per body query stamps so a body spanning several cells is only reported
+  // once per query without allocating a visited set
+  mutable std::vector<uint32_t> stamps;
+  mutable uint32_t currentStamp = 0;
+};
+
+} // namespace vkh
@@ -143,18 +143,8 @@ void init(EngineContext &context) {
   keybinds[Action::PlaceFreehand] = GLFW_KEY_F;
 }
 
-bool checkCollisionWithEntities(const std::vector<EntitySys::Entity> &entities,
-                                const AABB &aabb) {
-  for (const auto &entity : entities) {
-    if (entity.getWorldAABB().intersects(aabb)) {
-      return true;
-    }
-  }
-  return false;
-}
-
 glm::dvec2 lastPos;
-void update(EngineContext &context, std::vector<EntitySys::Entity> entities) {
+void update(EngineContext &context, const CollisionWorld &collisionWorld) {
   glm::dvec2 currentPos;
   glfwGetCursorPos(context.window, &currentPos.x, &currentPos.y);
 
@@ -204,30 +194,14 @@ void update(EngineContext &context, std::vector<EntitySys::Entity> entities) {
     glm::vec3 velocity =
         glm::normalize(moveDir) * sprint * moveSpeed * context.frameInfo.dt;
 
-    // Helper lambda to check if a specific position collides with any entity
-    auto checkCollision = [&](const glm::vec3 &testPos) {
-      // Shrunk the player slightly so they don't scrape the walls in 1x1
-      // corridors
-      const AABB playerAABB{testPos + glm::vec3{-0.2f, -0.4f, -0.2f},
-                            testPos + glm::vec3{0.2f, 0.4f, 0.2f}};
-
-      return checkCollisionWithEntities(entities, playerAABB);
-    };
-
-    // Apply sliding collision by testing each axis independently
-    glm::vec3 newPosition = context.camera.position;
-
-    if (!checkCollision(newPosition + glm::vec3{velocity.x, 0.f, 0.f})) {
-      newPosition.x += velocity.x;
-    }
-    if (!checkCollision(newPosition + glm::vec3{0.f, velocity.y, 0.f})) {
-      newPosition.y += velocity.y;
-    }
-    if (!checkCollision(newPosition + glm::vec3{0.f, 0.f, velocity.z})) {
-      newPosition.z += velocity.z;
-    }
-
-    context.camera.position = newPosition;
+    // Shrunk the player slightly so they don't scrape the walls in 1x1
+    // corridors
+    const glm::vec3 halfExtents{0.2f, 0.4f, 0.2f};
+    const AABB playerAABB{context.camera.position - halfExtents,
+                          context.camera.position + halfExtents};
+
+    // Swept so a long frame while sprinting can't tunnel through a wall
+    context.camera.position += collisionWorld.slide(playerAABB, velocity);
   }
 }
 } // namespace input
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "collisionWorld.hpp"
 #include "systems/entity/entities.hpp"
 
 #include <glm/glm.hpp>
@@ -11,7 +12,7 @@ namespace vkh {
 class EngineContext;
 namespace input {
 void init(EngineContext &context);
-void update(EngineContext &context, std::vector<EntitySys::Entity> entities);
+void update(EngineContext &context, const CollisionWorld &collisionWorld);
 extern glm::dvec2 lastPos;
 enum class Action {
   MoveForward,
@@ -166,6 +166,22 @@ void EntitySys::updateBuffers() {
     return;
   }
 
+  // Instance data is laid out in entity order, so as long as no entity was
+  // added or removed only the dirty ones need rebuilding (often none at all)
+  if (!structuralDirty && cpuInstanceData.size() == entities.size()) {
+    for (size_t i : dirtyInstances)
+      cpuInstanceData[i] =
+          buildInstanceData(entities[i], cpuInstanceData[i].jointOffset);
+    if (!dirtyInstances.empty()) {
+      for (size_t i = 0; i < framesDirty.size(); ++i)
+        framesDirty[i] = true;
+    }
+    dirtyInstances.clear();
+    writeCullingUbo();
+    return;
+  }
+  dirtyInstances.clear();
+
   if (structuralDirty) {
     cpuDrawCommands.clear();
     sceneBatches.clear();
@@ -208,30 +224,11 @@ void EntitySys::updateBuffers() {
         }
       }
 
-      auto &firstMat =
-          currentScene->materials[mesh.primitives[0].materialIndex];
-      int32_t texIdx = firstMat.baseColorTextureIndex.value_or(-1);
-      int32_t mrTexIdx = firstMat.metallicRoughnessTextureIndex.value_or(-1);
-
       for (size_t inst = j; inst < k; ++inst) {
-        AABB worldAABB = entities[inst].getWorldAABB();
-
-        GPUInstanceData data;
-        data.modelMatrix = entities[inst].transform.mat4() * mesh.transform;
-        data.normalMatrix = glm::mat4(entities[inst].transform.normalMatrix());
-        data.color = entities[inst].color * firstMat.baseColorFactor;
-        data.aabbMin = worldAABB.min;
-        data.aabbMax = worldAABB.max;
-        data.textureIndex = texIdx;
-        data.metallicRoughnessTextureIndex = mrTexIdx;
-        data.roughnessFactor = firstMat.roughnessFactor;
-        data.metallicFactor = firstMat.metallicFactor.x;
-        data.jointOffset = mesh.skinIndex.has_value()
-                               ? static_cast<int32_t>(currentJointOffset)
-                               : -1;
-        data.isVisible = 1;
-
-        cpuInstanceData.push_back(data);
+        cpuInstanceData.push_back(buildInstanceData(
+            entities[inst], mesh.skinIndex.has_value()
+                                ? static_cast<int32_t>(currentJointOffset)
+                                : -1));
       }
 
       j = k;
@@ -259,6 +256,36 @@ void EntitySys::updateBuffers() {
     }
   }
 
+  writeCullingUbo();
+
+  structuralDirty = false;
+  for (size_t i = 0; i < framesDirty.size(); ++i)
+    framesDirty[i] = true;
+}
+
+EntitySys::GPUInstanceData
+EntitySys::buildInstanceData(const Entity &entity, int32_t jointOffset) const {
+  auto &mesh = entity.getMesh();
+  auto &firstMat = entity.scene->materials[mesh.primitives[0].materialIndex];
+  AABB worldAABB = entity.getWorldAABB();
+
+  GPUInstanceData data;
+  data.modelMatrix = entity.transform.mat4() * mesh.transform;
+  data.normalMatrix = glm::mat4(entity.transform.normalMatrix());
+  data.color = entity.color * firstMat.baseColorFactor;
+  data.aabbMin = worldAABB.min;
+  data.aabbMax = worldAABB.max;
+  data.textureIndex = firstMat.baseColorTextureIndex.value_or(-1);
+  data.metallicRoughnessTextureIndex =
+      firstMat.metallicRoughnessTextureIndex.value_or(-1);
+  data.roughnessFactor = firstMat.roughnessFactor;
+  data.metallicFactor = firstMat.metallicFactor.x;
+  data.jointOffset = jointOffset;
+  data.isVisible = 1;
+  return data;
+}
+
+void EntitySys::writeCullingUbo() {
   int frameIndex = context.frameInfo.frameIndex;
   auto planes = camera::getFrustumPlanes(context.camera.projectionMatrix *
                                          context.camera.viewMatrix);
@@ -270,10 +297,6 @@ void EntitySys::updateBuffers() {
   cullingUboBuffers[frameIndex]->map();
   cullingUboBuffers[frameIndex]->write(&ubo, sizeof(CullingUbo));
   cullingUboBuffers[frameIndex]->unmap();
-
-  structuralDirty = false;
-  for (size_t i = 0; i < framesDirty.size(); ++i)
-    framesDirty[i] = true;
 }
 
 void EntitySys::flushBuffers(int frameIndex) {
@@ -55,7 +55,7 @@ public:
     glm::vec3 scale{1.f, 1.f, 1.f};
 
     glm::mat4 mat4() const;
-    glm::mat3 normalMatrix();
+    glm::mat3 normalMatrix() const;
   };
 
   struct RigidBody {
@@ -153,11 +153,20 @@ private:
   std::vector<glm::mat4> cpuJointData;
   std::vector<bool> framesDirty;
   bool structuralDirty = true;
+  std::vector<size_t> dirtyInstances;
 
+  GPUInstanceData buildInstanceData(const Entity &entity,
+                                    int32_t jointOffset) const;
+  void writeCullingUbo();
   void flushBuffers(int frameIndex);
 
 public:
   void markStructuralDirty() { structuralDirty = true; }
+  // Only the instance data of this entity gets rebuilt on the next
+  // updateBuffers(), use after touching its transform or color
+  void markInstanceDirty(size_t entityIndex) {
+    dirtyInstances.push_back(entityIndex);
+  }
 };
 
 } // namespace vkh
@@ -55,7 +55,7 @@ glm::mat4 EntitySys::Transform::mat4() const {
   return transform;
 }
 
-glm::mat3 EntitySys::Transform::normalMatrix() {
+glm::mat3 EntitySys::Transform::normalMatrix() const {
   glm::mat3 R = glm::mat3_cast(orientation);
 
   glm::mat3 S = glm::mat3(1.0f);
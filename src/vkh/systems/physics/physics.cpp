@@ -0,0 +1,38 @@
+#include "physics.hpp"
+
+#include "../../engineContext.hpp"
+
+namespace vkh {
+
+PhysicsSys::PhysicsSys(EngineContext &context, EntitySys &entitySys,
+                       const CollisionWorld &staticWorld)
+    : System(context), world{staticWorld}, entitySys{entitySys} {}
+
+uint32_t PhysicsSys::addEntity(size_t entityIndex) {
+  auto &entity = entitySys.entities[entityIndex];
+  AABB aabb = entity.getWorldAABB();
+  glm::vec3 center = (aabb.min + aabb.max) * .5f;
+
+  uint32_t body =
+      world.addBody(center, (aabb.max - aabb.min) * .5f,
+                    entity.rigidBody.mass, entity.rigidBody.velocity);
+  if (body >= links.size())
+    links.resize(body + 1);
+  links[body] = {entityIndex, center - entity.transform.position};
+  return body;
+}
+
+void PhysicsSys::update() {
+  if (!world.advance(context.frameInfo.dt))
+    return;
+
+  for (uint32_t body : world.getMovedBodies()) {
+    const Link &link = links[body];
+    auto &entity = entitySys.entities[link.entityIndex];
+    entity.transform.position = world.getCenter(body) - link.centerOffset;
+    entity.rigidBody.velocity = world.getVelocity(body);
+    entitySys.markInstanceDirty(link.entityIndex);
+  }
+}
+
+} // namespace vkh
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "../entity/entities.hpp"
+#include "../system.hpp"
+#include "physicsWorld.hpp"
+
+#include <vector>
+
+namespace vkh {
+
+// Drives EntitySys::RigidBody through a PhysicsWorld and writes the results
+// back into the entities through the dirty instance path
+class PhysicsSys : public System {
+public:
+  PhysicsSys(EngineContext &context, EntitySys &entitySys,
+             const CollisionWorld &staticWorld);
+
+  // Starts simulating the entity, its world AABB becomes the collision box
+  uint32_t addEntity(size_t entityIndex);
+
+  void update();
+
+  PhysicsWorld world;
+
+private:
+  EntitySys &entitySys;
+
+  struct Link {
+    size_t entityIndex;
+    glm::vec3 centerOffset;
+  };
+  std::vector<Link> links; // Indexed by body
+};
+
+} // namespace vkh
@@ -0,0 +1,227 @@
+#include "physicsWorld.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VKH_PHYSICS_SSE
+#endif
+
+namespace vkh {
+
+PhysicsWorld::PhysicsWorld(const CollisionWorld &staticWorld)
+    : staticWorld{staticWorld} {}
+
+uint32_t PhysicsWorld::addBody(glm::vec3 center, glm::vec3 halfExtents,
+                               float mass, glm::vec3 velocity) {
+  uint32_t body = static_cast<uint32_t>(slotToBody.size());
+  size_t slot = slotToBody.size();
+
+  posX.push_back(center.x);
+  posY.push_back(center.y);
+  posZ.push_back(center.z);
+  velX.push_back(velocity.x);
+  velY.push_back(velocity.y);
+  velZ.push_back(velocity.z);
+  halfX.push_back(halfExtents.x);
+  halfY.push_back(halfExtents.y);
+  halfZ.push_back(halfExtents.z);
+  invMass.push_back(mass > 0.f ? 1.f / mass : 0.f);
+  restSteps.push_back(0);
+  slotToBody.push_back(body);
+  bodyToSlot.push_back(static_cast<uint32_t>(slot));
+  movedFlags.push_back(0);
+
+  // New bodies start awake
+  swapSlots(slot, awakeCount);
+  awakeCount++;
+  return body;
+}
+
+void PhysicsWorld::swapSlots(size_t a, size_t b) {
+  if (a == b)
+    return;
+  std::swap(posX[a], posX[b]);
+  std::swap(posY[a], posY[b]);
+  std::swap(posZ[a], posZ[b]);
+  std::swap(velX[a], velX[b]);
+  std::swap(velY[a], velY[b]);
+  std::swap(velZ[a], velZ[b]);
+  std::swap(halfX[a], halfX[b]);
+  std::swap(halfY[a], halfY[b]);
+  std::swap(halfZ[a], halfZ[b]);
+  std::swap(invMass[a], invMass[b]);
+  std::swap(restSteps[a], restSteps[b]);
+  std::swap(slotToBody[a], slotToBody[b]);
+  bodyToSlot[slotToBody[a]] = static_cast<uint32_t>(a);
+  bodyToSlot[slotToBody[b]] = static_cast<uint32_t>(b);
+}
+
+void PhysicsWorld::wake(uint32_t body) {
+  size_t slot = bodyToSlot[body];
+  if (slot < awakeCount)
+    return;
+  restSteps[slot] = 0;
+  swapSlots(slot, awakeCount);
+  awakeCount++;
+}
+
+void PhysicsWorld::sleep(size_t slot) {
+  velX[slot] = velY[slot] = velZ[slot] = 0.f;
+  awakeCount--;
+  swapSlots(slot, awakeCount);
+}
+
+void PhysicsWorld::applyImpulse(uint32_t body, glm::vec3 impulse) {
+  wake(body);
+  size_t slot = bodyToSlot[body];
+  velX[slot] += impulse.x * invMass[slot];
+  velY[slot] += impulse.y * invMass[slot];
+  velZ[slot] += impulse.z * invMass[slot];
+}
+
+glm::vec3 PhysicsWorld::getCenter(uint32_t body) const {
+  size_t slot = bodyToSlot[body];
+  return {posX[slot], posY[slot], posZ[slot]};
+}
+
+glm::vec3 PhysicsWorld::getVelocity(uint32_t body) const {
+  size_t slot = bodyToSlot[body];
+  return {velX[slot], velY[slot], velZ[slot]};
+}
+
+int PhysicsWorld::advance(float dt) {
+  for (uint32_t body : movedBodies)
+    movedFlags[body] = 0;
+  movedBodies.clear();
+
+  accumulator += dt;
+  int steps = 0;
+  while (accumulator >= fixedDt && steps < maxStepsPerAdvance) {
+    step();
+    accumulator -= fixedDt;
+    steps++;
+  }
+  // Drop whatever couldn't be simulated instead of carrying it over forever
+  if (steps == maxStepsPerAdvance)
+    accumulator = std::min(accumulator, fixedDt);
+  return steps;
+}
+
+void PhysicsWorld::integrate() {
+  const size_t count = awakeCount;
+  const glm::vec3 dv = gravity * fixedDt;
+  size_t i = 0;
+
+#ifdef VKH_PHYSICS_SSE
+  const __m128 dt4 = _mm_set1_ps(fixedDt);
+  const __m128 damping4 = _mm_set1_ps(linearDamping);
+  const __m128 dvx4 = _mm_set1_ps(dv.x);
+  const __m128 dvy4 = _mm_set1_ps(dv.y);
+  const __m128 dvz4 = _mm_set1_ps(dv.z);
+  for (; i + 4 <= count; i += 4) {
+    __m128 vx = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velX[i]), dvx4), damping4);
+    __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velY[i]), dvy4), damping4);
+    __m128 vz = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&velZ[i]), dvz4), damping4);
+    _mm_storeu_ps(&velX[i], vx);
+    _mm_storeu_ps(&velY[i], vy);
+    _mm_storeu_ps(&velZ[i], vz);
+    _mm_storeu_ps(&posX[i],
+                  _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, dt4)));
+    _mm_storeu_ps(&posY[i],
+                  _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, dt4)));
+    _mm_storeu_ps(&posZ[i],
+                  _mm_add_ps(_mm_loadu_ps(&posZ[i]), _mm_mul_ps(vz, dt4)));
+  }
+#endif
+
+  for (; i < count; i++) {
+    velX[i] = (velX[i] + dv.x) * linearDamping;
+    velY[i] = (velY[i] + dv.y) * linearDamping;
+    velZ[i] = (velZ[i] + dv.z) * linearDamping;
+    posX[i] += velX[i] * fixedDt;
+    posY[i] += velY[i] * fixedDt;
+    posZ[i] += velZ[i] * fixedDt;
+  }
+}
+
+void PhysicsWorld::resolveStaticContacts(size_t slot) {
+  glm::vec3 center{posX[slot], posY[slot], posZ[slot]};
+  const glm::vec3 half{halfX[slot], halfY[slot], halfZ[slot]};
+  glm::vec3 velocity{velX[slot], velY[slot], velZ[slot]};
+
+  staticWorld.query(
+      AABB{center - half, center + half},
+      [&](uint32_t, const AABB &other) {
+        AABB box{center - half, center + half};
+        if (!box.intersects(other))
+          return false;
+
+        // Push out along the axis of least penetration
+        glm::vec3 overlapMin = other.max - box.min;
+        glm::vec3 overlapMax = box.max - other.min;
+        int axis = 0;
+        float depth = std::numeric_limits<float>::max();
+        float direction = 1.f;
+        for (int a = 0; a < 3; a++) {
+          if (overlapMin[a] < depth) {
+            depth = overlapMin[a];
+            axis = a;
+            direction = 1.f;
+          }
+          if (overlapMax[a] < depth) {
+            depth = overlapMax[a];
+            axis = a;
+            direction = -1.f;
+          }
+        }
+        center[axis] += depth * direction;
+
+        // Fully inelastic along the normal, some friction on the others
+        if (velocity[axis] * direction < 0.f) {
+          velocity[axis] = 0.f;
+          for (int a = 0; a < 3; a++)
+            if (a != axis)
+              velocity[a] *= 1.f - friction;
+        }
+        return false;
+      });
+
+  posX[slot] = center.x;
+  posY[slot] = center.y;
+  posZ[slot] = center.z;
+  velX[slot] = velocity.x;
+  velY[slot] = velocity.y;
+  velZ[slot] = velocity.z;
+}
+
+void PhysicsWorld::step() {
+  integrate();
+
+  for (size_t slot = 0; slot < awakeCount; slot++) {
+    resolveStaticContacts(slot);
+
+    uint32_t body = slotToBody[slot];
+    if (!movedFlags[body]) {
+      movedFlags[body] = 1;
+      movedBodies.push_back(body);
+    }
+  }
+
+  // Walk backwards so a body swapped into a freed slot was already handled
+  const float sleepSpeed2 = sleepSpeed * sleepSpeed;
+  for (size_t slot = awakeCount; slot-- > 0;) {
+    float speed2 = velX[slot] * velX[slot] + velY[slot] * velY[slot] +
+                   velZ[slot] * velZ[slot];
+    if (speed2 > sleepSpeed2) {
+      restSteps[slot] = 0;
+      continue;
+    }
+    if (++restSteps[slot] >= stepsBeforeSleep)
+      sleep(slot);
+  }
+}
+
+} // namespace vkh
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "../../collisionWorld.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace vkh {
+
+// Rigid body simulation stepped at a fixed rate, independent of the frame
+// rate. Bodies are stored as structure of arrays with every awake body packed
+// at the front, integration runs over contiguous lanes and sleeping bodies sit
+// behind them untouched until something wakes them up.
+class PhysicsWorld {
+public:
+  static constexpr float fixedDt = 1.f / 60.f;
+  // Caps the catch up after a long frame so a hitch can't snowball
+  static constexpr int maxStepsPerAdvance = 8;
+  static constexpr float linearDamping = .995f;
+  static constexpr float friction = .2f;
+  static constexpr float sleepSpeed = .05f;
+  static constexpr uint16_t stepsBeforeSleep = 30;
+
+  PhysicsWorld(const CollisionWorld &staticWorld);
+
+  glm::vec3 gravity{0.f, -9.81f, 0.f};
+
+  uint32_t addBody(glm::vec3 center, glm::vec3 halfExtents, float mass,
+                   glm::vec3 velocity = {});
+
+  // Runs every fixed step that fits in dt plus what was left over by the
+  // previous calls, returns the number of steps taken
+  int advance(float dt);
+  void step();
+
+  void wake(uint32_t body);
+  void applyImpulse(uint32_t body, glm::vec3 impulse);
+
+  glm::vec3 getCenter(uint32_t body) const;
+  glm::vec3 getVelocity(uint32_t body) const;
+  bool isAwake(uint32_t body) const { return bodyToSlot[body] < awakeCount; }
+
+  size_t getBodyCount() const { return slotToBody.size(); }
+  size_t getAwakeCount() const { return awakeCount; }
+
+  // Bodies that moved during the last advance(), each listed once
+  const std::vector<uint32_t> &getMovedBodies() const { return movedBodies; }
+
+private:
+  void integrate();
+  void resolveStaticContacts(size_t slot);
+  void sleep(size_t slot);
+  void swapSlots(size_t a, size_t b);
+
+  const CollisionWorld &staticWorld;
+  float accumulator = 0.f;
+
+  // Indexed by slot, [0, awakeCount) are the awake bodies
+  std::vector<float> posX, posY, posZ;
+  std::vector<float> velX, velY, velZ;
+  std::vector<float> halfX, halfY, halfZ;
+  std::vector<float> invMass;
+  std::vector<uint16_t> restSteps;
+  std::vector<uint32_t> slotToBody;
+  size_t awakeCount = 0;
+
+  // Indexed by body
+  std::vector<uint32_t> bodyToSlot;
+  std::vector<uint8_t> movedFlags;
+
+  std::vector<uint32_t> movedBodies;
+};
+
+} // namespace vkh